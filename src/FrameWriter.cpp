@@ -0,0 +1,364 @@
+#include "FrameWriter.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+FrameFormat parseFrameFormat(const std::string& name)
+{
+    if (name == "png")
+        return FrameFormat::PNG;
+    if (name == "ppm")
+        return FrameFormat::PPM;
+    if (name == "raw")
+        return FrameFormat::Raw;
+
+    throw std::invalid_argument("Unknown frame format '" + name + "' (expected 'png', 'ppm' or 'raw')");
+}
+
+std::string getFrameFormatName(FrameFormat format)
+{
+    if (format == FrameFormat::PPM)
+        return "ppm";
+    if (format == FrameFormat::Raw)
+        return "raw";
+
+    return "png";
+}
+
+FrameWriter::FrameWriter(int width, int height, const FrameWriterSettings& settings, int end_frame)
+{
+    _width = width;
+    _height = height;
+    _settings = settings;
+
+    _stopping = false;
+    _last_submitted_frame = -1;
+    _completed_through = -1;
+
+    _raw_frames = nullptr;
+    _raw_mapped_size = 0;
+    _raw_file_descriptor = -1;
+
+    _queued_frames = 0;
+    _buffers_in_use = 0;
+
+    if (_settings.format == FrameFormat::Raw)
+        mapRawFile(end_frame);
+
+    // Buffers are allocated once up front and recycled for the rest of the run
+    _buffers.resize(std::max(1, _settings.num_buffers));
+    for (FrameBuffer& buffer : _buffers)
+    {
+        buffer.pitch = _width * 4;
+        buffer.pixels.resize(static_cast<std::size_t>(buffer.pitch) * _height);
+        _free_buffers.push_back(&buffer);
+    }
+
+    _num_workers = _settings.num_threads;
+    if (_num_workers <= 0)
+        _num_workers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+
+    _worker_counters = std::make_unique<WorkerCounters[]>(_num_workers);
+
+    for (int i = 0; i < _num_workers; i++)
+        _workers.emplace_back(&FrameWriter::runWorker, this, i);
+}
+
+FrameWriter::~FrameWriter()
+{
+    stopWorkers();
+}
+
+FrameBuffer* FrameWriter::acquireBuffer()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _buffer_available.wait(lock, [this] { return !_free_buffers.empty(); });
+    throwIfFailed();
+
+    FrameBuffer* buffer = _free_buffers.back();
+    _free_buffers.pop_back();
+    _buffers_in_use.fetch_add(1, std::memory_order_relaxed);
+
+    return buffer;
+}
+
+void FrameWriter::submitFrame(FrameBuffer* buffer, int frame)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push_back({buffer, frame, -1});
+        recordSubmittedFrame(frame);
+
+        // Counted before the lock is released, so a worker can't finish the job and decrement first
+        _queued_frames.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    _job_available.notify_one();
+}
+
+void FrameWriter::submitRepeatedFrame(int frame)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        throwIfFailed();
+
+        if (_last_submitted_frame < 0)
+            throw std::logic_error("No earlier frame to repeat as frame " + std::to_string(frame));
+
+        _jobs.push_back({nullptr, frame, _last_submitted_frame});
+        recordSubmittedFrame(frame);
+
+        // Counted before the lock is released, so a worker can't finish the job and decrement first
+        _queued_frames.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    _job_available.notify_one();
+}
+
+void FrameWriter::finish()
+{
+    stopWorkers();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    throwIfFailed();
+}
+
+void FrameWriter::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+
+    // Workers drain every queued frame before exiting
+    _job_available.notify_all();
+
+    for (std::thread& worker : _workers)
+    {
+        if (worker.joinable())
+            worker.join();
+    }
+
+    _workers.clear();
+    unmapRawFile();
+}
+
+std::size_t FrameWriter::getQueuedFrameCount() const
+{
+    return _queued_frames.load(std::memory_order_relaxed);
+}
+
+std::size_t FrameWriter::getBuffersInUse() const
+{
+    return _buffers_in_use.load(std::memory_order_relaxed);
+}
+
+std::uint64_t FrameWriter::getFramesWritten() const
+{
+    std::uint64_t frames_written = 0;
+
+    for (int i = 0; i < _num_workers; i++)
+        frames_written += _worker_counters[i].frames_written.load(std::memory_order_relaxed);
+
+    return frames_written;
+}
+
+std::string FrameWriter::getFrameFilename(int frame, FrameFormat format)
+{
+    if (format == FrameFormat::Raw)
+        return FRAMES_DIRECTORY + RAW_FRAMES_FILE_NAME;
+
+    std::string extension = format == FrameFormat::PPM ? ".ppm" : ".png";
+    return FRAMES_DIRECTORY + "frame_" + std::to_string(frame) + extension;
+}
+
+std::size_t FrameWriter::getRawFrameSize(int width, int height)
+{
+    // Frames are stored back to back as BGR, 3 bytes per pixel
+    return static_cast<std::size_t>(width) * height * 3;
+}
+
+void FrameWriter::throwIfFailed() const
+{
+    if (!_error.empty())
+        throw std::runtime_error(_error);
+}
+
+void FrameWriter::recordSubmittedFrame(int frame)
+{
+    // Frames before the first one submitted were written by an earlier run
+    if (_last_submitted_frame < 0)
+        _completed_through = frame - 1;
+
+    _last_submitted_frame = frame;
+}
+
+void FrameWriter::recordCompletedFrame(int frame)
+{
+    _completed_frames.insert(frame);
+
+    // Only frames finished ahead of an earlier one stay in the set, so it never holds more than the frames in flight
+    while (!_completed_frames.empty() && *_completed_frames.begin() == _completed_through + 1)
+    {
+        _completed_frames.erase(_completed_frames.begin());
+        _completed_through++;
+    }
+}
+
+void FrameWriter::runWorker(int worker_num)
+{
+    std::atomic<std::uint64_t>& frames_written = _worker_counters[worker_num].frames_written;
+
+    cv::Mat bgr_image;
+
+    while (true)
+    {
+        FrameJob job;
+        bool failed;
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _job_available.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+
+            if (_jobs.empty())
+                return;
+
+            job = _jobs.front();
+            _jobs.pop_front();
+            failed = !_error.empty();
+        }
+
+        // After a failure the remaining jobs are only drained, so their buffers return to the pool
+        std::string error;
+        if (!failed)
+        {
+            try
+            {
+                if (job.buffer)
+                    writeFrame(job, bgr_image);
+                else
+                    writeRepeatedFrame(job);
+            }
+            catch (const std::exception& e)
+            {
+                error = e.what();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_error.empty())
+                _error = error;
+
+            recordCompletedFrame(job.frame);
+
+            if (job.buffer)
+                _free_buffers.push_back(job.buffer);
+        }
+
+        if (job.buffer)
+            _buffers_in_use.fetch_sub(1, std::memory_order_relaxed);
+
+        _queued_frames.fetch_sub(1, std::memory_order_relaxed);
+        if (!failed && error.empty())
+            frames_written.store(frames_written.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        _frame_completed.notify_all();
+        _buffer_available.notify_one();
+    }
+}
+
+void FrameWriter::writeFrame(const FrameJob& job, cv::Mat& bgr_image)
+{
+    cv::Mat bgra_image(_height, _width, CV_8UC4, job.buffer->pixels.data(), job.buffer->pitch);
+
+    if (_settings.format == FrameFormat::Raw)
+    {
+        // Convert straight into the frame's slot of the mapped file
+        cv::Mat slot(_height, _width, CV_8UC3, _raw_frames + job.frame * getRawFrameSize(_width, _height));
+        cv::cvtColor(bgra_image, slot, cv::COLOR_BGRA2BGR);
+        return;
+    }
+
+    cv::cvtColor(bgra_image, bgr_image, cv::COLOR_BGRA2BGR); // Convert to BGR format
+
+    std::vector<int> params;
+    if (_settings.format == FrameFormat::PNG)
+        params = {cv::IMWRITE_PNG_COMPRESSION, _settings.png_compression};
+
+    std::string filename = getFrameFilename(job.frame, _settings.format);
+    if (!cv::imwrite(filename, bgr_image, params))
+        throw std::runtime_error("Could not write frame: " + filename);
+}
+
+void FrameWriter::writeRepeatedFrame(const FrameJob& job)
+{
+    // Jobs are taken in order, so the source frame is already written or being written by another worker
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _frame_completed.wait(lock, [this, &job] { return job.repeat_of <= _completed_through || _completed_frames.count(job.repeat_of) > 0; });
+    }
+
+    if (_settings.format == FrameFormat::Raw)
+    {
+        std::size_t frame_size = getRawFrameSize(_width, _height);
+        std::memcpy(_raw_frames + job.frame * frame_size, _raw_frames + job.repeat_of * frame_size, frame_size);
+        return;
+    }
+
+    // Link to the previous image instead of compressing an identical frame again
+    std::string previous_filename = getFrameFilename(job.repeat_of, _settings.format);
+    std::string filename = getFrameFilename(job.frame, _settings.format);
+
+    std::error_code error;
+    std::filesystem::create_hard_link(previous_filename, filename, error);
+
+    if (error)
+        std::filesystem::copy_file(previous_filename, filename, std::filesystem::copy_options::overwrite_existing);
+}
+
+void FrameWriter::mapRawFile(int end_frame)
+{
+    std::string filename = getFrameFilename(0, FrameFormat::Raw);
+    _raw_mapped_size = getRawFrameSize(_width, _height) * end_frame;
+
+    // Frames already stored by a previous run are kept; the file is only grown to fit the new ones
+    _raw_file_descriptor = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (_raw_file_descriptor < 0 || ftruncate(_raw_file_descriptor, _raw_mapped_size) != 0)
+    {
+        std::cerr << "Could not create raw frame file: " << filename << std::endl;
+        exit(1);
+    }
+
+    if (_raw_mapped_size == 0)
+        return;
+
+    void* mapping = mmap(nullptr, _raw_mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, _raw_file_descriptor, 0);
+    if (mapping == MAP_FAILED)
+    {
+        std::cerr << "Could not map raw frame file: " << filename << std::endl;
+        exit(1);
+    }
+
+    _raw_frames = static_cast<unsigned char*>(mapping);
+}
+
+void FrameWriter::unmapRawFile()
+{
+    if (_raw_frames)
+    {
+        munmap(_raw_frames, _raw_mapped_size);
+        _raw_frames = nullptr;
+    }
+
+    if (_raw_file_descriptor >= 0)
+    {
+        close(_raw_file_descriptor);
+        _raw_file_descriptor = -1;
+    }
+}
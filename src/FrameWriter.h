@@ -0,0 +1,107 @@
+#ifndef FRAME_WRITER_H
+#define FRAME_WRITER_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+const std::string FRAMES_DIRECTORY = "Image Frames/";
+const std::string RAW_FRAMES_FILE_NAME = "frames.raw";
+
+enum class FrameFormat { PNG, PPM, Raw };
+
+struct FrameWriterSettings
+{
+    FrameFormat format = FrameFormat::PNG;
+    int png_compression = 3; // 0 (fastest, largest files) to 9 (slowest, smallest files)
+    int num_buffers = 8;
+    int num_threads = 0; // 0 uses every spare hardware thread
+};
+
+FrameFormat parseFrameFormat(const std::string& name);
+std::string getFrameFormatName(FrameFormat format);
+
+// Reusable buffer holding one frame read back from the renderer (ARGB8888, i.e. BGRA in memory)
+struct FrameBuffer
+{
+    std::vector<unsigned char> pixels;
+    int pitch;
+};
+
+// Writes frames on a pool of worker threads from a fixed pool of frame buffers. The simulation thread
+// only blocks when every buffer is still waiting to be written.
+class FrameWriter
+{
+private:
+    struct FrameJob
+    {
+        FrameBuffer* buffer; // nullptr for a frame that repeats 'repeat_of'
+        int frame;
+        int repeat_of;
+    };
+
+    // Each worker only updates its own counter, kept on its own cache line
+    struct alignas(64) WorkerCounters
+    {
+        std::atomic<std::uint64_t> frames_written{0};
+    };
+
+    int _width, _height;
+    FrameWriterSettings _settings;
+    std::vector<FrameBuffer> _buffers;
+    std::vector<FrameBuffer*> _free_buffers;
+    std::deque<FrameJob> _jobs;
+    int _completed_through; // Every frame up to and including this one has been written
+    std::set<int> _completed_frames; // Frames past _completed_through that finished out of order
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _job_available;
+    std::condition_variable _buffer_available;
+    std::condition_variable _frame_completed;
+    bool _stopping;
+    std::string _error; // First write failure hit by a worker; rethrown on the simulation thread
+    int _last_submitted_frame;
+    unsigned char* _raw_frames; // Memory-mapped contents of the raw frame file
+    std::size_t _raw_mapped_size;
+    int _raw_file_descriptor;
+    int _num_workers;
+    std::unique_ptr<WorkerCounters[]> _worker_counters;
+    std::atomic<std::size_t> _queued_frames;
+    std::atomic<std::size_t> _buffers_in_use;
+public:
+    FrameWriter(int width, int height, const FrameWriterSettings& settings, int end_frame);
+    ~FrameWriter();
+    // acquireBuffer, submitRepeatedFrame and finish throw std::runtime_error once a frame could not be written
+    FrameBuffer* acquireBuffer();
+    void submitFrame(FrameBuffer* buffer, int frame);
+    void submitRepeatedFrame(int frame);
+    void finish();
+    // Lock-free reads for progress reporting
+    std::size_t getQueuedFrameCount() const;
+    std::size_t getBuffersInUse() const;
+    std::uint64_t getFramesWritten() const;
+    static std::string getFrameFilename(int frame, FrameFormat format);
+    static std::size_t getRawFrameSize(int width, int height);
+private:
+    // These are called with _mutex held
+    void recordSubmittedFrame(int frame);
+    void recordCompletedFrame(int frame);
+    void throwIfFailed() const;
+    void stopWorkers();
+    void runWorker(int worker_num);
+    void writeFrame(const FrameJob& job, cv::Mat& bgr_image);
+    void writeRepeatedFrame(const FrameJob& job);
+    void mapRawFile(int end_frame);
+    void unmapRawFile();
+};
+
+#endif
@@ -0,0 +1,129 @@
+#include "MetricsReporter.h"
+#include "include/json/include/nlohmann/json.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+
+MetricsReporter::MetricsReporter(const MetricsSettings& settings, std::function<RunMetrics()> sample_metrics)
+{
+    _settings = settings;
+    _settings.interval_ms = std::max(_settings.interval_ms, MIN_METRICS_INTERVAL_MS);
+    _sample_metrics = std::move(sample_metrics);
+    _stopping = false;
+
+    _start_time = std::chrono::steady_clock::now();
+    _last_sample_time = _start_time;
+    _last_frames_simulated = _sample_metrics().frames_simulated;
+
+    if (!_settings.file_name.empty())
+        _thread = std::thread(&MetricsReporter::run, this);
+}
+
+MetricsReporter::~MetricsReporter()
+{
+    stop();
+}
+
+void MetricsReporter::stop()
+{
+    if (!_thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+
+    _stop_requested.notify_all();
+    _thread.join();
+
+    // Leave the final state of the run behind
+    writeMetrics();
+}
+
+void MetricsReporter::run()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while (!_stop_requested.wait_for(lock, std::chrono::milliseconds(_settings.interval_ms), [this] { return _stopping; }))
+    {
+        lock.unlock();
+        writeMetrics();
+        lock.lock();
+    }
+}
+
+void MetricsReporter::writeMetrics()
+{
+    RunMetrics metrics = _sample_metrics();
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    // Rate over the last interval, so slowdowns and stalls show up right away
+    double interval_seconds = std::chrono::duration<double>(now - _last_sample_time).count();
+    double frames_per_second = 0;
+    if (interval_seconds > 0)
+        frames_per_second = (metrics.frames_simulated - _last_frames_simulated) / interval_seconds;
+
+    _last_sample_time = now;
+    _last_frames_simulated = metrics.frames_simulated;
+
+    int remaining_frames = std::max(0, metrics.end_frame - metrics.current_frame - 1);
+
+    nlohmann::json j;
+    j["current_frame"] = metrics.current_frame;
+    j["end_frame"] = metrics.end_frame;
+    j["elapsed_seconds"] = std::chrono::duration<double>(now - _start_time).count();
+    j["frames_per_second"] = frames_per_second;
+    j["estimated_seconds_remaining"] = frames_per_second > 0 ? nlohmann::json(remaining_frames / frames_per_second) : nlohmann::json(nullptr);
+    j["frames_simulated"] = metrics.frames_simulated;
+    j["broadphase_runs"] = metrics.broadphase_runs;
+    j["broadphase_candidate_pairs"] = metrics.candidate_pairs;
+    j["collision_pairs"] = metrics.collision_pairs;
+    j["frame_writer_queue_depth"] = metrics.frame_writer_queue_depth;
+    j["frame_writer_buffers_in_use"] = metrics.frame_writer_buffers_in_use;
+    j["frames_written"] = metrics.frames_written;
+    j["resident_memory_bytes"] = getResidentMemoryBytes();
+
+    // Write to a temporary file first so readers never see a partially written stats file
+    std::string temp_file_name = _settings.file_name + ".tmp";
+    std::ofstream file(temp_file_name);
+    if (!file.is_open())
+    {
+        std::cerr << "Unable to open metrics file for writing\n";
+        return;
+    }
+
+    file << j.dump(4);
+    file.close();
+
+    std::error_code error;
+    std::filesystem::rename(temp_file_name, _settings.file_name, error);
+}
+
+std::size_t MetricsReporter::getResidentMemoryBytes()
+{
+#ifdef __APPLE__
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS)
+        return 0;
+
+    return info.resident_size;
+#else
+    // Second field of statm is the resident set size in pages
+    std::ifstream statm("/proc/self/statm");
+    std::size_t total_pages = 0, resident_pages = 0;
+
+    if (!(statm >> total_pages >> resident_pages))
+        return 0;
+
+    return resident_pages * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
@@ -0,0 +1,60 @@
+#ifndef METRICS_REPORTER_H
+#define METRICS_REPORTER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Shortest interval between stats file rewrites; smaller (or non-positive) settings are raised to it
+const int MIN_METRICS_INTERVAL_MS = 100;
+
+struct MetricsSettings
+{
+    std::string file_name; // Empty disables reporting
+    int interval_ms = 1000;
+};
+
+// Point-in-time view of an in-progress run, gathered from lock-free counters
+struct RunMetrics
+{
+    int current_frame;
+    int end_frame;
+    std::uint64_t frames_simulated;
+    std::uint64_t broadphase_runs;
+    std::uint64_t candidate_pairs;
+    std::uint64_t collision_pairs;
+    std::size_t frame_writer_queue_depth;
+    std::size_t frame_writer_buffers_in_use;
+    std::uint64_t frames_written;
+};
+
+// Periodically rewrites a JSON stats file describing a run, from a background thread, so long renders can
+// be monitored (and stalls detected) without touching the simulation thread
+class MetricsReporter
+{
+private:
+    MetricsSettings _settings;
+    std::function<RunMetrics()> _sample_metrics;
+    std::thread _thread;
+    std::mutex _mutex;
+    std::condition_variable _stop_requested;
+    bool _stopping;
+    std::chrono::steady_clock::time_point _start_time;
+    std::chrono::steady_clock::time_point _last_sample_time;
+    std::uint64_t _last_frames_simulated;
+public:
+    MetricsReporter(const MetricsSettings& settings, std::function<RunMetrics()> sample_metrics);
+    ~MetricsReporter();
+    void stop();
+private:
+    void run();
+    void writeMetrics();
+    static std::size_t getResidentMemoryBytes();
+};
+
+#endif
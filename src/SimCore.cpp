@@ -0,0 +1,99 @@
+#include "SimCore.h"
+#include <stdexcept>
+#include <tuple>
+
+namespace
+{
+    // Creates a core of one policy from a ball set of either precision
+    struct SimCoreFactory
+    {
+        std::unique_ptr<SimCore> (*from_float)(const SimCoreSettings&, int, int, float, float, BallSet);
+        std::unique_ptr<SimCore> (*from_double)(const SimCoreSettings&, int, int, float, float, BasicBallSet<double>);
+    };
+
+    // Key: precision, gravity enabled, elastic response, broadphase
+    using SimPolicyKey = std::tuple<SimPrecision, bool, bool, SimBroadphase>;
+
+    template <typename Policy, typename InputScalar>
+    std::unique_ptr<SimCore> makeSimCore(const SimCoreSettings& settings, int width, int height, float x_gravity, float y_gravity,
+        BasicBallSet<InputScalar> ball_set)
+    {
+        return std::make_unique<BasicSimCore<Policy>>(width, height, x_gravity, y_gravity, std::move(ball_set), settings);
+    }
+
+    template <typename Policy>
+    SimCoreFactory simCoreFactory()
+    {
+        return {makeSimCore<Policy, float>, makeSimCore<Policy, double>};
+    }
+
+    // Gravity is enabled only when non-zero, elastic response only when every ball has an elasticity factor of 1
+    SimPolicyKey getSimPolicyKey(const SimCoreSettings& settings, float x_gravity, float y_gravity, const std::vector<BallMaterial>& materials)
+    {
+        bool use_gravity = x_gravity != 0 || y_gravity != 0;
+        bool elastic = true;
+
+        for (const BallMaterial& material : materials)
+        {
+            if (material.collision_elasticity_factor != 1)
+            {
+                elastic = false;
+                break;
+            }
+        }
+
+        return std::make_tuple(settings.precision, use_gravity, elastic, settings.broadphase);
+    }
+
+    const std::map<SimPolicyKey, SimCoreFactory> SIM_CORE_FACTORIES = {
+        {{SimPrecision::Float, false, false, SimBroadphase::SweepAndPrune}, simCoreFactory<SimPolicy<float, false, false, SweepAndPruneBroadphase>>()},
+        {{SimPrecision::Float, false, true, SimBroadphase::SweepAndPrune}, simCoreFactory<SimPolicy<float, false, true, SweepAndPruneBroadphase>>()},
+        {{SimPrecision::Float, true, false, SimBroadphase::SweepAndPrune}, simCoreFactory<SimPolicy<float, true, false, SweepAndPruneBroadphase>>()},
+        {{SimPrecision::Float, true, true, SimBroadphase::SweepAndPrune}, simCoreFactory<SimPolicy<float, true, true, SweepAndPruneBroadphase>>()},
+        {{SimPrecision::Float, false, false, SimBroadphase::BruteForce}, simCoreFactory<SimPolicy<float, false, false, BruteForceBroadphase>>()},
+        {{SimPrecision::Float, false, true, SimBroadphase::BruteForce}, simCoreFactory<SimPolicy<float, false, true, BruteForceBroadphase>>()},
+        {{SimPrecision::Float, true, false, SimBroadphase::BruteForce}, simCoreFactory<SimPolicy<float, true, false, BruteForceBroadphase>>()},
+        {{SimPrecision::Float, true, true, SimBroadphase::BruteForce}, simCoreFactory<SimPolicy<float, true, true, BruteForceBroadphase>>()},
+        {{SimPrecision::Double, false, false, SimBroadphase::SweepAndPrune}, simCoreFactory<SimPolicy<double, false, false, SweepAndPruneBroadphase>>()},
+        {{SimPrecision::Double, false, true, SimBroadphase::SweepAndPrune}, simCoreFactory<SimPolicy<double, false, true, SweepAndPruneBroadphase>>()},
+        {{SimPrecision::Double, true, false, SimBroadphase::SweepAndPrune}, simCoreFactory<SimPolicy<double, true, false, SweepAndPruneBroadphase>>()},
+        {{SimPrecision::Double, true, true, SimBroadphase::SweepAndPrune}, simCoreFactory<SimPolicy<double, true, true, SweepAndPruneBroadphase>>()},
+        {{SimPrecision::Double, false, false, SimBroadphase::BruteForce}, simCoreFactory<SimPolicy<double, false, false, BruteForceBroadphase>>()},
+        {{SimPrecision::Double, false, true, SimBroadphase::BruteForce}, simCoreFactory<SimPolicy<double, false, true, BruteForceBroadphase>>()},
+        {{SimPrecision::Double, true, false, SimBroadphase::BruteForce}, simCoreFactory<SimPolicy<double, true, false, BruteForceBroadphase>>()},
+        {{SimPrecision::Double, true, true, SimBroadphase::BruteForce}, simCoreFactory<SimPolicy<double, true, true, BruteForceBroadphase>>()}};
+}
+
+SimPrecision parseSimPrecision(const std::string& name)
+{
+    if (name == "float")
+        return SimPrecision::Float;
+    if (name == "double")
+        return SimPrecision::Double;
+
+    throw std::invalid_argument("Unknown precision '" + name + "' (expected 'float' or 'double')");
+}
+
+SimBroadphase parseSimBroadphase(const std::string& name)
+{
+    if (name == "sweep_and_prune")
+        return SimBroadphase::SweepAndPrune;
+    if (name == "brute_force")
+        return SimBroadphase::BruteForce;
+
+    throw std::invalid_argument("Unknown broadphase '" + name + "' (expected 'sweep_and_prune' or 'brute_force')");
+}
+
+std::unique_ptr<SimCore> createSimCore(const SimCoreSettings& settings, int width, int height, float x_gravity, float y_gravity,
+    BallSet ball_set)
+{
+    SimPolicyKey key = getSimPolicyKey(settings, x_gravity, y_gravity, ball_set.materials);
+    return SIM_CORE_FACTORIES.at(key).from_float(settings, width, height, x_gravity, y_gravity, std::move(ball_set));
+}
+
+std::unique_ptr<SimCore> createSimCore(const SimCoreSettings& settings, int width, int height, float x_gravity, float y_gravity,
+    BasicBallSet<double> ball_set)
+{
+    SimPolicyKey key = getSimPolicyKey(settings, x_gravity, y_gravity, ball_set.materials);
+    return SIM_CORE_FACTORIES.at(key).from_double(settings, width, height, x_gravity, y_gravity, std::move(ball_set));
+}
@@ -0,0 +1,764 @@
+#ifndef SIMCORE_H
+#define SIMCORE_H
+
+#include "include/json/include/nlohmann/json.hpp"
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
+#include <unordered_set>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+// Properties shared by every ball made of the same material
+struct BallMaterial
+{
+    int radius;
+    float collision_elasticity_factor; // 0 (all energy lost) to 1 (no energy loss)
+};
+
+template <typename Scalar>
+struct BasicBall
+{
+    Scalar x, y;
+    Scalar vx, vy;
+    std::uint16_t material; // Index into the owning ball set's materials
+    std::uint8_t color; // Index into POSSIBLE_BALL_COLORS
+};
+
+using Ball = BasicBall<float>;
+
+static_assert(sizeof(Ball) <= 20, "Ball should stay compact enough for multi-million-ball scenes");
+
+// Balls together with the materials they reference
+template <typename Scalar>
+struct BasicBallSet
+{
+    std::vector<BasicBall<Scalar>> balls;
+    std::vector<BallMaterial> materials;
+
+    std::uint16_t getMaterialIndex(int radius, float collision_elasticity_factor);
+    void addBall(Scalar x, Scalar y, Scalar vx, Scalar vy, int radius, float collision_elasticity_factor, std::uint8_t color);
+};
+
+using BallSet = BasicBallSet<float>;
+
+template <typename Scalar>
+void to_json(nlohmann::json& j, const BasicBallSet<Scalar>& ball_set);
+// Same layout as to_json(BasicBallSet), for balls and materials that aren't held in a ball set
+template <typename Scalar>
+void ballsToJson(nlohmann::json& j, const std::vector<BasicBall<Scalar>>& balls, const std::vector<BallMaterial>& materials);
+template <typename Scalar>
+void from_json(const nlohmann::json& j, BasicBallSet<Scalar>& ball_set);
+
+const std::vector<std::vector<int>> POSSIBLE_BALL_COLORS = {{255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {204, 204, 0}, {102, 204, 0},
+    {0, 204, 0}, {0, 204, 102}, {0, 204, 204}, {0, 102, 204}, {0, 0, 204}, {102, 0, 204}, {204, 0, 204}, {204, 0, 102},
+    {153, 76, 0}, {153, 153, 0}, {76, 153, 0}, {0, 153, 0}, {0, 153, 76}, {0, 153, 153}, {0, 76, 153}, {0, 0, 153}, {76, 0, 153},
+    {153, 0, 153}, {153, 0, 76}, {204, 102, 0}, {153, 0, 0}, {204, 0, 0}, {255, 128, 0}, {255, 255, 0}, {128, 255, 0},
+    {0, 255, 128}, {0, 255, 255}, {0, 128, 255}, {127, 0, 255}, {255, 0, 255}, {255, 0, 127}, {255, 51, 51}, {255, 153, 51},
+    {255, 255, 51}, {153, 255, 51}, {51, 255, 51}, {51, 255, 153}, {51, 255, 255}, {51, 153, 255}, {51, 51, 255}, {153, 51, 255},
+    {255, 51, 255}, {255, 51, 153}, {255, 178, 102}, {255, 255, 102}, {178, 255, 102}, {102, 255, 102}, {102, 255, 178},
+    {102, 255, 255}, {102, 178, 255}, {102, 102, 255}, {178, 102, 255}, {255, 102, 255}, {255, 102, 178}};
+
+// Sweep and Prune along the x axis; on average O(nlogn)
+template <typename Scalar>
+class SweepAndPruneBroadphase
+{
+private:
+    std::multimap<Scalar, std::string> _current_1D_Ball_locations;
+public:
+    void generateCandidatePairs(const std::vector<BasicBall<Scalar>>& balls, const std::vector<BallMaterial>& materials,
+        std::vector<std::pair<int, int>>& candidate_pairs);
+};
+
+// Tests every pair of balls; O(n^2), but without any sorting overhead for very small scenes
+template <typename Scalar>
+class BruteForceBroadphase
+{
+public:
+    void generateCandidatePairs(const std::vector<BasicBall<Scalar>>& balls, const std::vector<BallMaterial>& materials,
+        std::vector<std::pair<int, int>>& candidate_pairs);
+};
+
+// Compile-time feature set of a simulation core. Disabled features are removed from the stepping code entirely.
+template <typename ScalarType, bool UseGravity, bool Elastic, template <typename> class BroadphaseType>
+struct SimPolicy
+{
+    using Scalar = ScalarType;
+    using Broadphase = BroadphaseType<ScalarType>;
+    static constexpr bool use_gravity = UseGravity;
+    static constexpr bool elastic = Elastic; // Every ball has an elasticity factor of 1, so no energy is ever lost
+};
+
+using DefaultSimPolicy = SimPolicy<float, true, false, SweepAndPruneBroadphase>;
+
+enum class SimPrecision { Float, Double };
+enum class SimBroadphase { SweepAndPrune, BruteForce };
+
+// Run-time choices for a simulation core. Precision and broadphase select the compiled policy; the rest
+// are read by the core itself.
+struct SimCoreSettings
+{
+    SimPrecision precision = SimPrecision::Float;
+    SimBroadphase broadphase = SimBroadphase::SweepAndPrune;
+    bool adaptive_substepping = false; // Split each frame into sub-steps based on the fastest ball
+    int max_substeps = 16;
+};
+
+// Largest distance a ball may travel in one sub-step, as a fraction of the smallest ball radius
+const float SUBSTEP_MAX_TRAVEL_FRACTION = 0.5f;
+
+// Number of times overlaps still left after a sub-step's collisions are looked for and resolved
+const int SUBSTEP_RESOLUTION_PASSES = 4;
+
+// Running totals kept by a simulation core. Only the stepping thread writes them (relaxed atomic stores, no
+// locking), so any other thread can read them while the simulation runs.
+struct SimCoreCounters
+{
+    std::atomic<std::uint64_t> frames{0};
+    std::atomic<std::uint64_t> broadphase_runs{0};
+    std::atomic<std::uint64_t> candidate_pairs{0}; // Pairs reported by the broadphase
+    std::atomic<std::uint64_t> collision_pairs{0}; // Candidate pairs that actually overlapped
+};
+
+// Run-time interface to a simulation core, independent of the policy it was compiled with
+class SimCore
+{
+public:
+    virtual ~SimCore() = default;
+    virtual void step(int num_frames) = 0;
+    virtual int getWindowWidth() const = 0;
+    virtual int getWindowHeight() const = 0;
+    virtual float getXGravity() const = 0;
+    virtual float getYGravity() const = 0;
+    virtual std::size_t getBallCount() const = 0;
+    // Copies the current ball state (in single precision) into 'ball_set', reusing its storage
+    virtual void copyBallsTo(BallSet& ball_set) const = 0;
+    // Zero-copy view of the ball array of single precision cores; nullptr for double precision cores
+    virtual const Ball* getBallData() const = 0;
+    // Single precision copy of one ball; the slow path for cores getBallData() can't view
+    virtual Ball getBall(std::size_t index) const = 0;
+    virtual const std::vector<BallMaterial>& getMaterials() const = 0;
+    // Writes the ball state at the core's own precision, in the layout read back by from_json(BasicBallSet)
+    virtual void saveBalls(nlohmann::json& j) const = 0;
+    virtual const SimCoreCounters& getCounters() const = 0;
+};
+
+// Physics state, broadphase and collision response of the simulation. Has no dependency on
+// SDL or OpenCV so it can be embedded and stepped headless.
+template <typename Policy = DefaultSimPolicy>
+class BasicSimCore final : public SimCore
+{
+public:
+    using Scalar = typename Policy::Scalar;
+    using BallType = BasicBall<Scalar>;
+private:
+    int _window_width, _window_height;
+    Scalar _x_gravity, _y_gravity;
+    std::vector<BallType> _balls;
+    std::vector<BallMaterial> _materials;
+    typename Policy::Broadphase _broadphase;
+    std::vector<std::pair<int, int>> _candidate_pairs;
+    std::vector<std::pair<int, int>> _current_collisions;
+    bool _adaptive_substepping;
+    int _max_substeps;
+    int _min_radius;
+    SimCoreCounters _counters;
+public:
+    // Ball sets of the policy's own precision are moved in; others are converted
+    template <typename InputScalar>
+    BasicSimCore(int width, int height, float x_gravity, float y_gravity, BasicBallSet<InputScalar> ball_set,
+        const SimCoreSettings& settings = SimCoreSettings());
+    void step(int num_frames) override;
+    int getWindowWidth() const override;
+    int getWindowHeight() const override;
+    float getXGravity() const override;
+    float getYGravity() const override;
+    std::size_t getBallCount() const override;
+    void copyBallsTo(BallSet& ball_set) const override;
+    const Ball* getBallData() const override;
+    Ball getBall(std::size_t index) const override;
+    const std::vector<BallMaterial>& getMaterials() const override;
+    void saveBalls(nlohmann::json& j) const override;
+    const SimCoreCounters& getCounters() const override;
+    const std::vector<BallType>& getBalls() const;
+    // Direct (zero-copy) view of the ball array; positions are at x / y with a stride of sizeof(BallType)
+    const BallType* data() const;
+    BallType* data();
+private:
+    void updateSimulation();
+    int getSubstepCount() const;
+    void generateCollisionPairs();
+    void handleBallCollisions();
+    void handleBallCollisionsInPasses(int max_passes);
+    void handleSingleBallCollisionInstance(int ball_num1, int ball_num2, bool loseEnergy);
+    void handleWallCollisionForSpecificBall(BallType& current_ball);
+    std::pair<int, int> getCollidedPair();
+    void updateBallPosition(BallType& current_ball, Scalar dt);
+    bool collisionDetected(int ball_num1, int ball_num2);
+};
+
+SimPrecision parseSimPrecision(const std::string& name);
+SimBroadphase parseSimBroadphase(const std::string& name);
+
+// Picks the policy matching the given settings and initial state (gravity enabled only when non-zero,
+// elastic response only when every ball has an elasticity factor of 1) from a dispatch table
+std::unique_ptr<SimCore> createSimCore(const SimCoreSettings& settings, int width, int height, float x_gravity, float y_gravity,
+    BallSet ball_set);
+std::unique_ptr<SimCore> createSimCore(const SimCoreSettings& settings, int width, int height, float x_gravity, float y_gravity,
+    BasicBallSet<double> ball_set);
+
+template <typename Scalar>
+std::uint16_t BasicBallSet<Scalar>::getMaterialIndex(int radius, float collision_elasticity_factor)
+{
+    // Scenes only use a handful of materials, so a linear search is enough
+    for (std::size_t i = 0; i < materials.size(); i++)
+    {
+        if (materials[i].radius == radius && materials[i].collision_elasticity_factor == collision_elasticity_factor)
+            return static_cast<std::uint16_t>(i);
+    }
+
+    if (materials.size() > UINT16_MAX)
+        throw std::length_error("Too many distinct ball materials");
+
+    materials.push_back({radius, collision_elasticity_factor});
+    return static_cast<std::uint16_t>(materials.size() - 1);
+}
+
+template <typename Scalar>
+void BasicBallSet<Scalar>::addBall(Scalar x, Scalar y, Scalar vx, Scalar vy, int radius, float collision_elasticity_factor, std::uint8_t color)
+{
+    balls.push_back({x, y, vx, vy, getMaterialIndex(radius, collision_elasticity_factor), color});
+}
+
+template <typename Scalar>
+void to_json(nlohmann::json& j, const BasicBallSet<Scalar>& ball_set)
+{
+    ballsToJson(j, ball_set.balls, ball_set.materials);
+}
+
+template <typename Scalar>
+void ballsToJson(nlohmann::json& j, const std::vector<BasicBall<Scalar>>& balls, const std::vector<BallMaterial>& materials)
+{
+    j = nlohmann::json::array();
+
+    for (const BasicBall<Scalar>& b : balls)
+    {
+        const BallMaterial& material = materials[b.material];
+
+        j.push_back(nlohmann::json{
+            {"x", b.x},
+            {"y", b.y},
+            {"vx", b.vx},
+            {"vy", b.vy},
+            {"radius", material.radius},
+            {"collision_elasticity_factor", material.collision_elasticity_factor},
+            {"color", POSSIBLE_BALL_COLORS[b.color]}
+        });
+    }
+}
+
+template <typename Scalar>
+void from_json(const nlohmann::json& j, BasicBallSet<Scalar>& ball_set)
+{
+    ball_set.balls.clear();
+    ball_set.materials.clear();
+    ball_set.balls.reserve(j.size());
+
+    for (const nlohmann::json& ball_json : j)
+    {
+        Scalar x, y, vx, vy;
+        int radius;
+        float collision_elasticity_factor;
+        std::vector<int> color;
+
+        ball_json.at("x").get_to(x);
+        ball_json.at("y").get_to(y);
+        ball_json.at("vx").get_to(vx);
+        ball_json.at("vy").get_to(vy);
+        ball_json.at("radius").get_to(radius);
+        ball_json.at("collision_elasticity_factor").get_to(collision_elasticity_factor);
+        ball_json.at("color").get_to(color);
+
+        auto color_it = std::find(POSSIBLE_BALL_COLORS.begin(), POSSIBLE_BALL_COLORS.end(), color);
+        if (color_it == POSSIBLE_BALL_COLORS.end())
+            throw std::invalid_argument("Ball color is not in POSSIBLE_BALL_COLORS");
+
+        ball_set.addBall(x, y, vx, vy, radius, collision_elasticity_factor, static_cast<std::uint8_t>(color_it - POSSIBLE_BALL_COLORS.begin()));
+    }
+}
+
+template <typename Scalar>
+void SweepAndPruneBroadphase<Scalar>::generateCandidatePairs(const std::vector<BasicBall<Scalar>>& balls,
+    const std::vector<BallMaterial>& materials, std::vector<std::pair<int, int>>& candidate_pairs)
+{
+    // Maintain a sorted list of all essential one-dimensional ball locations
+    _current_1D_Ball_locations.clear();
+
+    for (int i = 0; i < static_cast<int>(balls.size()); i++)
+    {
+        int radius = materials[balls[i].material].radius;
+
+        _current_1D_Ball_locations.insert(std::make_pair(balls[i].x - radius, std::to_string(i) + "a"));
+        _current_1D_Ball_locations.insert(std::make_pair(balls[i].x + radius, std::to_string(i) + "b"));
+    }
+
+    std::unordered_set<int> buffer_nums;
+    candidate_pairs.clear();
+
+    for (const auto& pair : _current_1D_Ball_locations)
+    {
+        int ball_num = std::stoi(pair.second.substr(0, pair.second.length() - 1));
+
+        if (pair.second.find("a") != std::string::npos) // 'a' found so corresponds to left ball side
+            buffer_nums.insert(ball_num);
+        else
+        {
+            // Add possibility of collision between ball_num and all other nums inside buffer
+            for (auto it = buffer_nums.begin(); it != buffer_nums.end(); ++it)
+            {
+                if (*it != ball_num)
+                    candidate_pairs.push_back(std::make_pair(ball_num, *it));
+            }
+
+            buffer_nums.erase(ball_num);
+        }
+    }
+}
+
+template <typename Scalar>
+void BruteForceBroadphase<Scalar>::generateCandidatePairs(const std::vector<BasicBall<Scalar>>& balls,
+    const std::vector<BallMaterial>&, std::vector<std::pair<int, int>>& candidate_pairs)
+{
+    candidate_pairs.clear();
+
+    for (int i = 0; i < static_cast<int>(balls.size()); i++)
+    {
+        for (int j = i + 1; j < static_cast<int>(balls.size()); j++)
+            candidate_pairs.push_back(std::make_pair(i, j));
+    }
+}
+
+template <typename Policy>
+template <typename InputScalar>
+BasicSimCore<Policy>::BasicSimCore(int width, int height, float x_gravity, float y_gravity, BasicBallSet<InputScalar> ball_set,
+    const SimCoreSettings& settings)
+{
+    _window_width = width;
+    _window_height = height;
+
+    _x_gravity = x_gravity;
+    _y_gravity = y_gravity;
+
+    _materials = std::move(ball_set.materials);
+
+    // Take over the caller's storage when no precision conversion is needed
+    if constexpr (std::is_same<Scalar, InputScalar>::value)
+        _balls = std::move(ball_set.balls);
+    else
+    {
+        _balls.reserve(ball_set.balls.size());
+        for (const BasicBall<InputScalar>& b : ball_set.balls)
+            _balls.push_back({static_cast<Scalar>(b.x), static_cast<Scalar>(b.y), static_cast<Scalar>(b.vx), static_cast<Scalar>(b.vy),
+                b.material, b.color});
+    }
+
+    _adaptive_substepping = settings.adaptive_substepping;
+    _max_substeps = std::max(1, settings.max_substeps);
+
+    _min_radius = 0;
+    for (const BallMaterial& material : _materials)
+    {
+        if (_min_radius == 0 || material.radius < _min_radius)
+            _min_radius = material.radius;
+    }
+}
+
+template <typename Policy>
+void BasicSimCore<Policy>::step(int num_frames)
+{
+    // Advance the state of all free-moving objects by the requested number of frames
+    for (int frame = 0; frame < num_frames; ++frame)
+    {
+        updateSimulation();
+        _counters.frames.store(_counters.frames.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+}
+
+template <typename Policy>
+int BasicSimCore<Policy>::getWindowWidth() const
+{
+    return _window_width;
+}
+
+template <typename Policy>
+int BasicSimCore<Policy>::getWindowHeight() const
+{
+    return _window_height;
+}
+
+template <typename Policy>
+float BasicSimCore<Policy>::getXGravity() const
+{
+    return static_cast<float>(_x_gravity);
+}
+
+template <typename Policy>
+float BasicSimCore<Policy>::getYGravity() const
+{
+    return static_cast<float>(_y_gravity);
+}
+
+template <typename Policy>
+std::size_t BasicSimCore<Policy>::getBallCount() const
+{
+    return _balls.size();
+}
+
+template <typename Policy>
+void BasicSimCore<Policy>::copyBallsTo(BallSet& ball_set) const
+{
+    ball_set.materials = _materials;
+
+    if constexpr (std::is_same<Scalar, float>::value)
+        ball_set.balls = _balls;
+    else
+    {
+        ball_set.balls.resize(_balls.size());
+
+        for (std::size_t i = 0; i < _balls.size(); i++)
+        {
+            const BallType& b = _balls[i];
+            ball_set.balls[i] = {static_cast<float>(b.x), static_cast<float>(b.y), static_cast<float>(b.vx), static_cast<float>(b.vy),
+                b.material, b.color};
+        }
+    }
+}
+
+template <typename Policy>
+void BasicSimCore<Policy>::saveBalls(nlohmann::json& j) const
+{
+    ballsToJson(j, _balls, _materials);
+}
+
+template <typename Policy>
+const Ball* BasicSimCore<Policy>::getBallData() const
+{
+    if constexpr (std::is_same<Scalar, float>::value)
+        return _balls.data();
+    else
+        return nullptr;
+}
+
+template <typename Policy>
+Ball BasicSimCore<Policy>::getBall(std::size_t index) const
+{
+    const BallType& b = _balls[index];
+    return {static_cast<float>(b.x), static_cast<float>(b.y), static_cast<float>(b.vx), static_cast<float>(b.vy), b.material, b.color};
+}
+
+template <typename Policy>
+const std::vector<typename BasicSimCore<Policy>::BallType>& BasicSimCore<Policy>::getBalls() const
+{
+    return _balls;
+}
+
+template <typename Policy>
+const SimCoreCounters& BasicSimCore<Policy>::getCounters() const
+{
+    return _counters;
+}
+
+template <typename Policy>
+const std::vector<BallMaterial>& BasicSimCore<Policy>::getMaterials() const
+{
+    return _materials;
+}
+
+template <typename Policy>
+const typename BasicSimCore<Policy>::BallType* BasicSimCore<Policy>::data() const
+{
+    return _balls.data();
+}
+
+template <typename Policy>
+typename BasicSimCore<Policy>::BallType* BasicSimCore<Policy>::data()
+{
+    return _balls.data();
+}
+
+template <typename Policy>
+void BasicSimCore<Policy>::updateSimulation()
+{
+    if (!_adaptive_substepping)
+    {
+        // General position updates for each ball
+        for (BallType& ball : _balls)
+            updateBallPosition(ball, 1);
+
+        // Handles collisions between balls
+        handleBallCollisions();
+
+        // Collisions between walls
+        for (BallType& ball : _balls)
+            handleWallCollisionForSpecificBall(ball);
+
+        return;
+    }
+
+    // Short sub-steps keep overlaps shallow, so each one only needs a bounded amount of resolution work
+    int num_substeps = getSubstepCount();
+    Scalar dt = Scalar(1) / num_substeps;
+
+    for (int substep = 0; substep < num_substeps; substep++)
+    {
+        for (BallType& ball : _balls)
+            updateBallPosition(ball, dt);
+
+        handleBallCollisionsInPasses(SUBSTEP_RESOLUTION_PASSES);
+
+        for (BallType& ball : _balls)
+            handleWallCollisionForSpecificBall(ball);
+    }
+}
+
+template <typename Policy>
+int BasicSimCore<Policy>::getSubstepCount() const
+{
+    if (_min_radius <= 0)
+        return 1;
+
+    Scalar max_speed_squared = 0;
+    for (const BallType& ball : _balls)
+        max_speed_squared = std::max(max_speed_squared, ball.vx * ball.vx + ball.vy * ball.vy);
+
+    // Account for the speed gravity adds over the frame
+    Scalar max_speed = std::sqrt(max_speed_squared);
+    if constexpr (Policy::use_gravity)
+        max_speed += std::sqrt(_x_gravity * _x_gravity + _y_gravity * _y_gravity);
+
+    int num_substeps = static_cast<int>(std::ceil(max_speed / (SUBSTEP_MAX_TRAVEL_FRACTION * _min_radius)));
+    return std::clamp(num_substeps, 1, _max_substeps);
+}
+
+template <typename Policy>
+void BasicSimCore<Policy>::handleWallCollisionForSpecificBall(BallType& current_ball)
+{
+    int radius = _materials[current_ball.material].radius;
+    float collision_elasticity_factor = _materials[current_ball.material].collision_elasticity_factor;
+
+    // Bounce off the walls
+    if (current_ball.x - radius < 0 || current_ball.x + radius > _window_width)
+    {
+        current_ball.vx = -current_ball.vx;
+
+        // Adjust velocities to account for energy lost
+        if constexpr (!Policy::elastic)
+        {
+            if (std::abs(current_ball.vx / current_ball.vy) < 1)
+            {
+                current_ball.vx *= (sqrt(collision_elasticity_factor) + (1 - sqrt(collision_elasticity_factor)) * (1 - std::abs(current_ball.vx / current_ball.vy)));
+                current_ball.vy *= (sqrt(collision_elasticity_factor) + (1 - sqrt(collision_elasticity_factor)) * (1 - std::abs(current_ball.vx / current_ball.vy)));
+            }
+            else
+            {
+                current_ball.vx *= sqrt(collision_elasticity_factor);
+                current_ball.vy *= sqrt(collision_elasticity_factor);
+            }
+        }
+
+        // Keep inside box bounds
+        if (current_ball.x - radius < 0)
+            current_ball.x = radius;
+        else
+            current_ball.x = _window_width - radius;
+    }
+
+    if (current_ball.y - radius < 0 || current_ball.y + radius > _window_height)
+    {
+        current_ball.vy = -current_ball.vy;
+
+        if constexpr (!Policy::elastic)
+        {
+            if (std::abs(current_ball.vy / current_ball.vx) < 1)
+            {
+                current_ball.vx *= (sqrt(collision_elasticity_factor) + (1 - sqrt(collision_elasticity_factor)) * (1 - std::abs(current_ball.vy / current_ball.vx)));
+                current_ball.vy *= (sqrt(collision_elasticity_factor) + (1 - sqrt(collision_elasticity_factor)) * (1 - std::abs(current_ball.vy / current_ball.vx)));
+            }
+            else
+            {
+                current_ball.vx *= sqrt(collision_elasticity_factor);
+                current_ball.vy *= sqrt(collision_elasticity_factor);
+            }
+        }
+
+        if (current_ball.y - radius < 0)
+            current_ball.y = radius;
+        else
+            current_ball.y = _window_height - radius;
+    }
+}
+
+template <typename Policy>
+void BasicSimCore<Policy>::updateBallPosition(BallType& current_ball, Scalar dt)
+{
+    // Update velocity
+    if constexpr (Policy::use_gravity)
+    {
+        current_ball.vx += _x_gravity * dt;
+        current_ball.vy += _y_gravity * dt;
+    }
+
+    // Update position
+    current_ball.x += current_ball.vx * dt;
+    current_ball.y += current_ball.vy * dt;
+}
+
+template <typename Policy>
+void BasicSimCore<Policy>::generateCollisionPairs()
+{
+    _broadphase.generateCandidatePairs(_balls, _materials, _candidate_pairs);
+
+    _current_collisions.clear();
+
+    for (std::pair<int, int>& pair : _candidate_pairs)
+    {
+        if (collisionDetected(pair.first, pair.second))
+            _current_collisions.push_back(pair);
+    }
+
+    // This thread is the only writer, so plain load/store pairs are enough
+    _counters.broadphase_runs.store(_counters.broadphase_runs.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    _counters.candidate_pairs.store(_counters.candidate_pairs.load(std::memory_order_relaxed) + _candidate_pairs.size(), std::memory_order_relaxed);
+    _counters.collision_pairs.store(_counters.collision_pairs.load(std::memory_order_relaxed) + _current_collisions.size(), std::memory_order_relaxed);
+}
+
+template <typename Policy>
+std::pair<int, int> BasicSimCore<Policy>::getCollidedPair()
+{
+    generateCollisionPairs();
+
+    if (_current_collisions.size() > 0)
+        return _current_collisions[rand() % _current_collisions.size()];
+
+    return std::make_pair(-1, -1);
+}
+
+template <typename Policy>
+bool BasicSimCore<Policy>::collisionDetected(int ball_num1, int ball_num2)
+{
+    Scalar distance_between_midpoints = sqrt(pow(_balls[ball_num1].x - _balls[ball_num2].x, 2) + pow(_balls[ball_num1].y - _balls[ball_num2].y, 2));
+    Scalar sum_of_radii = _materials[_balls[ball_num1].material].radius + _materials[_balls[ball_num2].material].radius;
+
+    return sum_of_radii > distance_between_midpoints;
+}
+
+template <typename Policy>
+void BasicSimCore<Policy>::handleBallCollisions()
+{
+    // Get all pairs of balls that initially are collided with eachother
+    generateCollisionPairs();
+
+    // Handles all initial collisions
+    for (const std::pair<int, int>& pair : _current_collisions)
+        handleSingleBallCollisionInstance(pair.first, pair.second, true);
+
+    std::pair<int, int> pair = getCollidedPair();
+    std::size_t count = 0;
+
+    // Handle potential additional collisions caused by handling of initial collisions
+    while (pair.first != -1 && count < _balls.size() * _balls.size())
+    {
+        handleSingleBallCollisionInstance(pair.first, pair.second, false);
+
+        pair = getCollidedPair();
+        count++;
+    }
+}
+
+template <typename Policy>
+void BasicSimCore<Policy>::handleBallCollisionsInPasses(int max_passes)
+{
+    generateCollisionPairs();
+
+    for (const std::pair<int, int>& pair : _current_collisions)
+        handleSingleBallCollisionInstance(pair.first, pair.second, true);
+
+    // Overlaps stay shallow between sub-steps, so a few passes over all remaining pairs settle them
+    for (int pass = 0; pass < max_passes; pass++)
+    {
+        generateCollisionPairs();
+
+        if (_current_collisions.empty())
+            break;
+
+        for (const std::pair<int, int>& pair : _current_collisions)
+            handleSingleBallCollisionInstance(pair.first, pair.second, false);
+    }
+}
+
+template <typename Policy>
+void BasicSimCore<Policy>::handleSingleBallCollisionInstance(int ball_num1, int ball_num2, bool loseEnergy)
+{
+    BallType& ball1 = _balls[ball_num1];
+    BallType& ball2 = _balls[ball_num2];
+    const BallMaterial& material1 = _materials[ball1.material];
+    const BallMaterial& material2 = _materials[ball2.material];
+
+    // Vector between centers of the balls
+    Scalar dx = ball1.x - ball2.x;
+    Scalar dy = ball1.y - ball2.y;
+
+    // Distance between centers of the balls
+    Scalar d_mids = sqrt(dx * dx + dy * dy);
+
+    Scalar overlap = 0.5 * (d_mids - (material1.radius + material2.radius));
+
+    // Displace ball1 along the line of centers
+    ball1.x -= (overlap * (ball1.x - ball2.x) / d_mids) * 1.25;
+    ball1.y -= (overlap * (ball1.y - ball2.y) / d_mids) * 1.25;
+
+    // Displace ball2 along the line of centers
+    ball2.x += (overlap * (ball1.x - ball2.x) / d_mids) * 1.25;
+    ball2.y += (overlap * (ball1.y - ball2.y) / d_mids) * 1.25;
+
+    // Squared radii (mass proxies)
+    Scalar m1 = material1.radius * material1.radius;
+    Scalar m2 = material2.radius * material2.radius;
+
+    // Dot product of velocities and displacement vectors
+    Scalar dot_v1 = (ball1.vx - ball2.vx) * dx + (ball1.vy - ball2.vy) * dy;
+    Scalar dot_v2 = (ball2.vx - ball1.vx) * dx + (ball2.vy - ball1.vy) * dy;
+
+    // Scalar terms for updating velocities
+    Scalar scalar1 = (2 * m2) / (m1 + m2) * dot_v1 / (d_mids * d_mids);
+    Scalar scalar2 = (2 * m1) / (m1 + m2) * dot_v2 / (d_mids * d_mids);
+
+    // Update velocities of ball1 and ball2
+    ball1.vx -= scalar1 * dx;
+    ball1.vy -= scalar1 * dy;
+
+    ball2.vx -= scalar2 * dx;
+    ball2.vy -= scalar2 * dy;
+
+    if constexpr (!Policy::elastic)
+    {
+        if (loseEnergy) // Take into account energy loss component
+        {
+            ball1.vx *= sqrt(material1.collision_elasticity_factor);
+            ball1.vy *= sqrt(material1.collision_elasticity_factor);
+
+            ball2.vx *= sqrt(material2.collision_elasticity_factor);
+            ball2.vy *= sqrt(material2.collision_elasticity_factor);
+        }
+    }
+}
+
+#endif
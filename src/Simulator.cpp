@@ -5,41 +5,44 @@ Simulator::Simulator(int width, int height)
     _window_width = width;
     _window_height = height;
 
-    _x_gravity = 0;
-    _y_gravity = 1;
-
     int rand_color_index = rand() % POSSIBLE_BALL_COLORS.size();
 
-    Ball default_ball = {100, 100, 70, 44, 25, 1, POSSIBLE_BALL_COLORS[rand_color_index]};
-    _balls.push_back(default_ball);
+    BallSet default_balls;
+    default_balls.addBall(100, 100, 70, 44, 25, 1, rand_color_index);
+    _core = createSimCore(SimCoreSettings(), width, height, 0, 1, std::move(default_balls));
+    _resumed_project = false;
 
     initializeSimulation();
     deleteTempImageFiles();
 }
 
-Simulator::Simulator(int width, int height, float x_gravity, float y_gravity, std::vector<Ball>& balls)
+Simulator::Simulator(int width, int height, float x_gravity, float y_gravity, BallSet balls, const SimCoreSettings& settings)
 {
     _window_width = width;
     _window_height = height;
 
-    _x_gravity = x_gravity;
-    _y_gravity = y_gravity;
-
-    _balls = balls;
+    _core = createSimCore(settings, width, height, x_gravity, y_gravity, std::move(balls));
+    _resumed_project = false;
 
     initializeSimulation();
     deleteTempImageFiles();
 }
 
-Simulator::Simulator()
+Simulator::Simulator(const SimCoreSettings& settings)
 {
     // Loading last captured state from previous execution run
-    loadSimulationMetadata();
+    loadSimulationMetadata(settings);
     initializeSimulation();
 }
 
 Simulator::~Simulator() 
 {
+    if (_frame_texture) 
+    {
+        SDL_DestroyTexture(_frame_texture);
+        _frame_texture = nullptr;
+    }
+
     if (_renderer) 
     {
         SDL_DestroyRenderer(_renderer);
@@ -60,6 +63,7 @@ void Simulator::initializeSimulation()
     initializeSDL();
     createSDLWindow();
     createSDLRenderer();
+    createFrameBuffer();
 }
 
 void Simulator::initializeSDL()
@@ -99,124 +103,331 @@ void Simulator::createSDLRenderer()
     }
 }
 
-void Simulator::updateSimulation() 
+void Simulator::createFrameBuffer()
+{
+    _frame_texture = nullptr;
+    _ball_data = nullptr;
+    _has_previous_frame = false;
+
+    // Without render targets the previous frame can't be kept, so every frame gets redrawn in full
+    if (!SDL_RenderTargetSupported(_renderer))
+        return;
+
+    _frame_texture = SDL_CreateTexture(_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, _window_width, _window_height);
+
+    if (_frame_texture && SDL_SetRenderTarget(_renderer, _frame_texture) < 0)
+    {
+        SDL_DestroyTexture(_frame_texture);
+        _frame_texture = nullptr;
+    }
+}
+
+const SimCore& Simulator::getCore() const
 {
-    // General position updates for each ball
-    for (Ball& ball : _balls)
-        updateBallPosition(ball);
+    return *_core;
+}
+
+bool Simulator::renderSimulation() 
+{
+    _ball_data = _core->getBallData();
+
+    bool frame_changed = true;
+    bool full_redraw = true;
+
+    if (_has_previous_frame && _previous_ball_centers.size() == _core->getBallCount())
+    {
+        std::size_t moved_balls = collectDirtyRects();
+        frame_changed = moved_balls > 0;
+
+        long long dirty_area = 0;
+        for (const SDL_Rect& rect : _dirty_rects)
+            dirty_area += static_cast<long long>(rect.w) * rect.h;
+
+        // Redrawing only the dirty regions relies on the previous frame still being in the frame buffer
+        full_redraw = !_frame_texture || moved_balls > MAX_DIRTY_RECTS || dirty_area > FULL_REDRAW_COVERAGE_THRESHOLD * _window_width * _window_height;
+    }
+    else
+        storeBallCenters();
+
+    if (full_redraw)
+        renderFullFrame();
+    else if (frame_changed)
+        renderDirtyRegions();
+
+    _has_previous_frame = true;
 
-    // Handles collisions between balls
-    handleBallCollisions();
+    return frame_changed;
+}
+
+void Simulator::renderFullFrame()
+{
+    // Clear screen
+    SDL_SetRenderDrawColor(_renderer, 0x00, 0x00, 0x00, 0xFF);
+    SDL_RenderClear(_renderer);
 
-    // Collisions between walls
-    for (Ball& ball : _balls)
-        handleWallCollisionForSpecificBall(ball);
+    // Draw all the balls
+    drawAllBalls();
 }
 
-void Simulator::handleWallCollisionForSpecificBall(Ball& current_ball)
+void Simulator::renderDirtyRegions()
 {
-    // Bounce off the walls
-    if (current_ball.x - current_ball.radius < 0 || current_ball.x + current_ball.radius > _window_width) 
+    const std::vector<BallMaterial>& materials = _core->getMaterials();
+
+    int max_radius = 0;
+    for (const BallMaterial& material : materials)
+        max_radius = std::max(max_radius, material.radius);
+
+    int grid_columns = (_window_width + BALL_GRID_CELL_SIZE - 1) / BALL_GRID_CELL_SIZE;
+    int grid_rows = (_window_height + BALL_GRID_CELL_SIZE - 1) / BALL_GRID_CELL_SIZE;
+    buildBallGrid(grid_columns, grid_rows);
+
+    for (const SDL_Rect& rect : _dirty_rects)
     {
-        current_ball.vx = -current_ball.vx;
-        
-        // Adjust velocities to account for energy lost
-        if (abs(current_ball.vx / current_ball.vy) < 1)
+        SDL_SetRenderDrawColor(_renderer, 0x00, 0x00, 0x00, 0xFF);
+        SDL_RenderFillRect(_renderer, &rect);
+
+        // A ball reaches at most max_radius past the cell holding its center, so widen the search by that much
+        int first_column = std::max(0, (rect.x - max_radius) / BALL_GRID_CELL_SIZE);
+        int last_column = std::min(grid_columns - 1, (rect.x + rect.w - 1 + max_radius) / BALL_GRID_CELL_SIZE);
+        int first_row = std::max(0, (rect.y - max_radius) / BALL_GRID_CELL_SIZE);
+        int last_row = std::min(grid_rows - 1, (rect.y + rect.h - 1 + max_radius) / BALL_GRID_CELL_SIZE);
+
+        _region_balls.clear();
+
+        for (int row = first_row; row <= last_row; row++)
         {
-            current_ball.vx *= (sqrt(current_ball.collision_elasticity_factor) + (1 - sqrt(current_ball.collision_elasticity_factor)) * (1 - abs(current_ball.vx / current_ball.vy)));
-            current_ball.vy *= (sqrt(current_ball.collision_elasticity_factor) + (1 - sqrt(current_ball.collision_elasticity_factor)) * (1 - abs(current_ball.vx / current_ball.vy)));
+            for (int column = first_column; column <= last_column; column++)
+            {
+                for (int ball_num : _ball_grid[row * grid_columns + column])
+                {
+                    Ball ball = getBall(ball_num);
+                    SDL_Rect bounds = getBallBounds({static_cast<int>(ball.x), static_cast<int>(ball.y)}, materials[ball.material].radius);
+
+                    if (SDL_HasIntersection(&bounds, &rect))
+                        _region_balls.push_back(ball_num);
+                }
+            }
         }
-        else
+
+        // Redraw every ball touching the region, in the same order as a full redraw
+        std::sort(_region_balls.begin(), _region_balls.end());
+
+        for (int ball_num : _region_balls)
         {
-            current_ball.vx *= sqrt(current_ball.collision_elasticity_factor);
-            current_ball.vy *= sqrt(current_ball.collision_elasticity_factor);
+            Ball ball = getBall(ball_num);
+            drawBall(static_cast<int>(ball.x), static_cast<int>(ball.y), materials[ball.material].radius, POSSIBLE_BALL_COLORS[ball.color], rect);
         }
-        
-        // Keep inside box bounds
-        if (current_ball.x - current_ball.radius < 0)
-            current_ball.x = current_ball.radius;
-        else
-            current_ball.x = _window_width - current_ball.radius;
     }
-    
-    if (current_ball.y - current_ball.radius < 0 || current_ball.y + current_ball.radius > _window_height) 
+}
+
+void Simulator::storeBallCenters()
+{
+    _previous_ball_centers.resize(_core->getBallCount());
+
+    for (std::size_t i = 0; i < _previous_ball_centers.size(); i++)
+    {
+        Ball ball = getBall(i);
+        _previous_ball_centers[i] = {static_cast<int>(ball.x), static_cast<int>(ball.y)};
+    }
+}
+
+std::size_t Simulator::collectDirtyRects()
+{
+    const std::vector<BallMaterial>& materials = _core->getMaterials();
+    std::size_t moved_balls = 0;
+    _dirty_rects.clear();
+
+    // A ball that moved dirties the union of its old and new bounding boxes
+    for (std::size_t i = 0; i < _previous_ball_centers.size(); i++)
     {
-        current_ball.vy = -current_ball.vy;
+        Ball ball = getBall(i);
+        SDL_Point center = {static_cast<int>(ball.x), static_cast<int>(ball.y)};
+        SDL_Point& previous_center = _previous_ball_centers[i];
+
+        if (center.x == previous_center.x && center.y == previous_center.y)
+            continue;
 
-        if (abs(current_ball.vy / current_ball.vx) < 1)
+        // Past this many the frame is redrawn in full, so further rectangles aren't worth collecting
+        if (++moved_balls <= MAX_DIRTY_RECTS)
         {
-            current_ball.vx *= (sqrt(current_ball.collision_elasticity_factor) + (1 - sqrt(current_ball.collision_elasticity_factor)) * (1 - abs(current_ball.vy / current_ball.vx)));
-            current_ball.vy *= (sqrt(current_ball.collision_elasticity_factor) + (1 - sqrt(current_ball.collision_elasticity_factor)) * (1 - abs(current_ball.vy / current_ball.vx)));
+            int radius = materials[ball.material].radius;
+            SDL_Rect old_bounds = getBallBounds(previous_center, radius);
+            SDL_Rect new_bounds = getBallBounds(center, radius);
+
+            SDL_Rect dirty_rect;
+            SDL_UnionRect(&old_bounds, &new_bounds, &dirty_rect);
+            _dirty_rects.push_back(dirty_rect);
         }
-        else 
+
+        previous_center = center;
+    }
+
+    if (moved_balls <= MAX_DIRTY_RECTS)
+        mergeDirtyRects();
+
+    return moved_balls;
+}
+
+void Simulator::mergeDirtyRects()
+{
+    // Overlapping rectangles are combined so no region gets cleared and redrawn more than once.
+    // Merged rectangles are compacted into the front of _dirty_rects.
+    std::size_t merged_count = 0;
+
+    for (std::size_t i = 0; i < _dirty_rects.size(); i++)
+    {
+        SDL_Rect rect = _dirty_rects[i];
+        std::size_t j = 0;
+
+        while (j < merged_count)
         {
-            current_ball.vx *= sqrt(current_ball.collision_elasticity_factor);
-            current_ball.vy *= sqrt(current_ball.collision_elasticity_factor);
+            if (!SDL_HasIntersection(&rect, &_dirty_rects[j]))
+            {
+                j++;
+                continue;
+            }
+
+            SDL_Rect merged_rect;
+            SDL_UnionRect(&rect, &_dirty_rects[j], &merged_rect);
+            rect = merged_rect;
+
+            // The grown rectangle may now overlap ones it was already checked against
+            _dirty_rects[j] = _dirty_rects[--merged_count];
+            j = 0;
         }
-        
-        if (current_ball.y - current_ball.radius < 0)
-            current_ball.y = current_ball.radius;
-        else
-            current_ball.y = _window_height - current_ball.radius;
+
+        _dirty_rects[merged_count++] = rect;
+    }
+
+    _dirty_rects.resize(merged_count);
+}
+
+void Simulator::buildBallGrid(int grid_columns, int grid_rows)
+{
+    _ball_grid.resize(static_cast<std::size_t>(grid_columns) * grid_rows);
+    for (std::vector<int>& cell : _ball_grid)
+        cell.clear();
+
+    for (std::size_t i = 0; i < _previous_ball_centers.size(); i++)
+    {
+        // Centers were brought up to date by collectDirtyRects; ones outside the window go to the nearest edge cell
+        const SDL_Point& center = _previous_ball_centers[i];
+        int column = std::clamp(center.x / BALL_GRID_CELL_SIZE, 0, grid_columns - 1);
+        int row = std::clamp(center.y / BALL_GRID_CELL_SIZE, 0, grid_rows - 1);
+
+        _ball_grid[row * grid_columns + column].push_back(static_cast<int>(i));
     }
 }
 
-void Simulator::updateBallPosition(Ball& current_ball)
+SDL_Rect Simulator::getBallBounds(const SDL_Point& center, int radius)
 {
-    // Update velocity
-    current_ball.vx += _x_gravity;
-    current_ball.vy += _y_gravity;
+    return {center.x - radius, center.y - radius, radius * 2 + 1, radius * 2 + 1};
+}
 
-    // Update position
-    current_ball.x += current_ball.vx;
-    current_ball.y += current_ball.vy;
+void Simulator::saveFrame(int frame) 
+{
+    // Compression and disk writes happen on the frame writer's threads
+    FrameBuffer* buffer = _frame_writer->acquireBuffer();
+    SDL_RenderReadPixels(_renderer, NULL, SDL_PIXELFORMAT_ARGB8888, buffer->pixels.data(), buffer->pitch);
+    _frame_writer->submitFrame(buffer, frame);
 }
 
-void Simulator::renderSimulation() 
+void Simulator::setFrameWriterSettings(const FrameWriterSettings& settings)
 {
-    // Draw all the balls
-    drawAllBalls();
+    FrameFormat project_format = _frame_writer_settings.format;
+    _frame_writer_settings = settings;
+
+    // New frames have to match the ones already saved, or the video can't be put together from both
+    if (_resumed_project && settings.format != project_format)
+    {
+        std::cout << "Continuing with this project's '" << getFrameFormatName(project_format) << "' frame format instead of '"
+            << getFrameFormatName(settings.format) << "'\n";
+        _frame_writer_settings.format = project_format;
+    }
+}
+
+void Simulator::setMetricsSettings(const MetricsSettings& settings)
+{
+    _metrics_settings = settings;
 }
 
-void Simulator::saveFrame(const std::string& filename) 
+RunMetrics Simulator::sampleRunMetrics(int end_frame) const
 {
-    SDL_Surface* sshot = SDL_CreateRGBSurface(0, _window_width, _window_height, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
-    SDL_RenderReadPixels(_renderer, NULL, SDL_PIXELFORMAT_ARGB8888, sshot->pixels, sshot->pitch);
-    cv::Mat img = cv::Mat(sshot->h, sshot->w, CV_8UC4, sshot->pixels);
-    cv::cvtColor(img, img, cv::COLOR_BGRA2BGR); // Convert to BGR format
-    cv::imwrite(filename, img);
-    SDL_FreeSurface(sshot);
+    // Only reads atomics, so it is safe to call from the metrics thread while frames are rendered
+    const SimCoreCounters& counters = _core->getCounters();
+    RunMetrics metrics;
+
+    metrics.current_frame = _current_frame.load(std::memory_order_relaxed);
+    metrics.end_frame = end_frame;
+    metrics.frames_simulated = counters.frames.load(std::memory_order_relaxed);
+    metrics.broadphase_runs = counters.broadphase_runs.load(std::memory_order_relaxed);
+    metrics.candidate_pairs = counters.candidate_pairs.load(std::memory_order_relaxed);
+    metrics.collision_pairs = counters.collision_pairs.load(std::memory_order_relaxed);
+    metrics.frame_writer_queue_depth = _frame_writer->getQueuedFrameCount();
+    metrics.frame_writer_buffers_in_use = _frame_writer->getBuffersInUse();
+    metrics.frames_written = _frame_writer->getFramesWritten();
+
+    return metrics;
 }
 
 void Simulator::runSimulation(int num_frames)
 {
     int lastSavedFrameNum = getLastSavedPhotoFrameNum();
+    int end_frame = num_frames + lastSavedFrameNum + 1;
+
+    _frame_writer = std::make_unique<FrameWriter>(_window_width, _window_height, _frame_writer_settings, end_frame);
+    _current_frame.store(lastSavedFrameNum, std::memory_order_relaxed);
+
+    MetricsReporter metrics_reporter(_metrics_settings, [this, end_frame] { return sampleRunMetrics(end_frame); });
 
-    for (int frame = lastSavedFrameNum + 1; frame < num_frames + lastSavedFrameNum + 1; ++frame)
+    // The first frame of a run has no earlier frame in the writer to repeat, so it is always drawn and saved in full
+    _has_previous_frame = false;
+
+    try
     {
-        // State of all free-moving objects gets updated by one frame
-        updateSimulation();
+        for (int frame = lastSavedFrameNum + 1; frame < end_frame; ++frame)
+        {
+            _current_frame.store(frame, std::memory_order_relaxed);
 
-        // Clear screen
-        SDL_SetRenderDrawColor(_renderer, 0x00, 0x00, 0x00, 0xFF);
-        SDL_RenderClear(_renderer);
+            // State of all free-moving objects gets updated by one frame
+            _core->step(1);
+
+            // Update render screen based on updated object states
+            bool frame_changed = renderSimulation();
+
+            // Save the frame to an image file
+            if (frame_changed)
+                saveFrame(frame);
+            else
+                _frame_writer->submitRepeatedFrame(frame);
+        }
 
-        // Update render screen based on updated object states
-        renderSimulation();
+        // Wait for every queued frame to reach the disk
+        _frame_writer->finish();
+    }
+    catch (const std::exception& e)
+    {
+        // Stop the reporter and the writer's threads before exiting so nothing is still running during shutdown
+        metrics_reporter.stop();
+        _frame_writer.reset();
 
-        // Save the frame to an image file
-        std::string filename = "Image Frames/frame_" + std::to_string(frame) + ".png";
-        saveFrame(filename);
+        std::cerr << "Could not save frames: " << e.what() << std::endl;
+        exit(1);
     }
+
+    metrics_reporter.stop();
+    _frame_writer.reset();
 }
 
 void Simulator::deleteTempImageFiles() 
 {
     try 
     {
-        for (const auto& entry : std::filesystem::directory_iterator("Image Frames/")) 
+        for (const auto& entry : std::filesystem::directory_iterator(FRAMES_DIRECTORY)) 
         {
-            if (entry.is_regular_file() && entry.path().extension() == ".png")
+            std::string extension = entry.path().extension().string();
+
+            if (entry.is_regular_file() && (extension == ".png" || extension == ".ppm" || extension == ".raw"))
                 std::filesystem::remove(entry.path());
         }
     } 
@@ -234,14 +445,19 @@ void Simulator::deleteTempImageFiles()
 
 int Simulator::getLastSavedPhotoFrameNum() 
 {
-    std::string directoryPath = "Image Frames/";
+    std::string directoryPath = FRAMES_DIRECTORY;
     int largestFrameNum = -1;
 
-    std::regex frameRegex(R"(frame_(\d+)\.png)");
+    std::regex frameRegex(R"(frame_(\d+)\.(png|ppm))");
     std::smatch match;
 
     try 
     {
+        // The raw format keeps every frame in a single file
+        std::string raw_filename = FrameWriter::getFrameFilename(0, FrameFormat::Raw);
+        if (std::filesystem::exists(raw_filename))
+            return static_cast<int>(std::filesystem::file_size(raw_filename) / FrameWriter::getRawFrameSize(_window_width, _window_height)) - 1;
+
         for (const auto& entry : std::filesystem::directory_iterator(directoryPath)) 
         {
             if (entry.is_regular_file()) 
@@ -282,19 +498,10 @@ void Simulator::createVideoFromFrames(int frame_rate, const std::string& save_di
         exit(1);
     }
 
-    for (int frame = 0; frame < num_frames; ++frame) 
-    {
-        std::string filename = "Image Frames/frame_" + std::to_string(frame) + ".png";
-        cv::Mat img = cv::imread(filename);
-
-        if (img.empty()) 
-        {
-            std::cerr << "Could not read frame: " << filename << std::endl;
-            exit(1);
-        }
-
-        writer.write(img);
-    }
+    if (_frame_writer_settings.format == FrameFormat::Raw)
+        writeRawFramesToVideo(writer, num_frames);
+    else
+        writeImageFramesToVideo(writer, num_frames);
 
     writer.release();
 
@@ -306,168 +513,100 @@ void Simulator::createVideoFromFrames(int frame_rate, const std::string& save_di
     std::cout << "Video creation completed successfully!\n";
 }
 
-void Simulator::drawAllBalls()
-{
-    for (Ball& ball : _balls)
-        drawBall(static_cast<int>(ball.x), static_cast<int>(ball.y), ball.radius, ball.color);
-}
-
-void Simulator::drawBall(int centerX, int centerY, int radius, std::vector<int>& color) 
+void Simulator::writeImageFramesToVideo(cv::VideoWriter& writer, int num_frames)
 {
-    // Set the color for drawing the current specified ball
-    SDL_SetRenderDrawColor(_renderer, color[0], color[1], color[2], 0xFF);
+    cv::Mat img;
+    std::string previous_filename;
 
-    for (int w = 0; w < radius * 2; w++) 
+    for (int frame = 0; frame < num_frames; ++frame) 
     {
-        for (int h = 0; h < radius * 2; h++) 
-        {
-            int dx = radius - w; // horizontal offset
-            int dy = radius - h; // vertical offset
+        std::string filename = FrameWriter::getFrameFilename(frame, _frame_writer_settings.format);
 
-            if ((dx*dx + dy*dy) <= (radius * radius)) 
-            {
-                SDL_RenderDrawPoint(_renderer, centerX + dx, centerY + dy);
-            }
+        // Unchanged frames are links to the previous image, so the decoded image can be reused as is
+        std::error_code error;
+        if (!img.empty() && std::filesystem::equivalent(previous_filename, filename, error))
+        {
+            writer.write(img);
+            previous_filename = filename;
+            continue;
         }
-    }
-}
 
-void Simulator::update1DBallLocations()
-{
-    _current_1D_Ball_locations.clear();
+        img = cv::imread(filename);
 
-    for (int i = 0; i < _balls.size(); i++)
-    {
-        _current_1D_Ball_locations.insert(std::make_pair(_balls[i].x - _balls[i].radius, std::to_string(i) + "a"));
-        _current_1D_Ball_locations.insert(std::make_pair(_balls[i].x + _balls[i].radius, std::to_string(i) + "b"));
+        if (img.empty()) 
+        {
+            std::cerr << "Could not read frame: " << filename << std::endl;
+            exit(1);
+        }
+
+        writer.write(img);
+        previous_filename = filename;
     }
 }
 
-void Simulator::generateCollisionPairs()
+void Simulator::writeRawFramesToVideo(cv::VideoWriter& writer, int num_frames)
 {
-    std::vector<std::pair<int, int>> possible_collision_pairs;
-    std::unordered_set<int> buffer_nums;
+    std::string filename = FrameWriter::getFrameFilename(0, FrameFormat::Raw);
+    std::ifstream raw_file(filename, std::ios::binary);
+    cv::Mat img(_window_height, _window_width, CV_8UC3);
 
-    for (const auto& pair : _current_1D_Ball_locations) 
+    for (int frame = 0; frame < num_frames; ++frame) 
     {
-        int ball_num = std::stoi(pair.second.substr(0, pair.second.length() - 1));
-
-        if (pair.second.find("a") != std::string::npos) // 'a' found so corresponds to left ball side
-            buffer_nums.insert(ball_num);
-        else
+        if (!raw_file.read(reinterpret_cast<char*>(img.data), FrameWriter::getRawFrameSize(_window_width, _window_height)))
         {
-            // Add possibility of collision between ball_num and all other nums inside buffer
-            for (auto it = buffer_nums.begin(); it != buffer_nums.end(); ++it) 
-            {
-                if (*it != ball_num)
-                    possible_collision_pairs.push_back(std::make_pair(ball_num, *it));
-            }
-
-            buffer_nums.erase(ball_num);
+            std::cerr << "Could not read frame " << frame << " from: " << filename << std::endl;
+            exit(1);
         }
-    }
-
-    _current_collisions.clear();
 
-    for (std::pair<int, int>& pair : possible_collision_pairs)
-    {
-        if (collisionDetected(pair.first, pair.second))
-            _current_collisions.push_back(pair);
+        writer.write(img);
     }
 }
 
-std::pair<int, int> Simulator::getCollidedPair()
-{
-    update1DBallLocations();
-    generateCollisionPairs();
-
-    if (_current_collisions.size() > 0)
-        return _current_collisions[rand() % _current_collisions.size()];
-
-    return std::make_pair(-1, -1);
-}
-
-bool Simulator::collisionDetected(int ball_num1, int ball_num2)
-{
-    float distance_between_midpoints = sqrt(pow(_balls[ball_num1].x - _balls[ball_num2].x, 2) + pow(_balls[ball_num1].y - _balls[ball_num2].y, 2));
-    float sum_of_radii = _balls[ball_num1].radius + _balls[ball_num2].radius;
-
-    return sum_of_radii > distance_between_midpoints;
-}
-
-void Simulator::handleBallCollisions() 
+void Simulator::drawAllBalls()
 {
-    // Maintain a sorted list of all essential one-dimensional ball locations
-    update1DBallLocations();
+    const std::vector<BallMaterial>& materials = _core->getMaterials();
 
-    // Get all pairs of balls that initially are collided with eachother
-    generateCollisionPairs();
+    SDL_Rect window_rect = {0, 0, _window_width, _window_height};
 
-    // Handles all initial collisions
-    for (const std::pair<int, int>& pair : _current_collisions)
-        handleSingleBallCollisionInstance(pair.first, pair.second, true);
-
-    std::pair<int, int> pair = getCollidedPair();
-    int count = 0;
-
-    // Handle potential additional collisions caused by handling of initial collisions
-    while (pair.first != -1 && count < _balls.size() * _balls.size())
+    for (std::size_t i = 0; i < _core->getBallCount(); i++)
     {
-        handleSingleBallCollisionInstance(pair.first, pair.second, false);
-
-        pair = getCollidedPair();
-        count++;
+        Ball ball = getBall(i);
+        drawBall(static_cast<int>(ball.x), static_cast<int>(ball.y), materials[ball.material].radius, POSSIBLE_BALL_COLORS[ball.color], window_rect);
     }
 }
 
-void Simulator::handleSingleBallCollisionInstance(int ball_num1, int ball_num2, bool loseEnergy)
+Ball Simulator::getBall(std::size_t index) const
 {
-    Ball& ball1 = _balls[ball_num1];
-    Ball& ball2 = _balls[ball_num2];
-
-    // Vector between centers of the balls
-    float dx = ball1.x - ball2.x;
-    float dy = ball1.y - ball2.y;
-
-    // Distance between centers of the balls
-    float d_mids = sqrt(dx * dx + dy * dy);
-
-    float overlap = 0.5 * (d_mids - (ball1.radius + ball2.radius));
-
-    // Displace ball1 along the line of centers
-    ball1.x -= (overlap * (ball1.x - ball2.x) / d_mids) * 1.25;
-    ball1.y -= (overlap * (ball1.y - ball2.y) / d_mids) * 1.25;
-
-    // Displace ball2 along the line of centers
-    ball2.x += (overlap * (ball1.x - ball2.x) / d_mids) * 1.25;
-    ball2.y += (overlap * (ball1.y - ball2.y) / d_mids) * 1.25;
-
-    // Squared radii (mass proxies)
-    float m1 = ball1.radius * ball1.radius;
-    float m2 = ball2.radius * ball2.radius;
+    // Single precision cores are read in place; only double precision ones convert ball by ball
+    if (_ball_data)
+        return _ball_data[index];
 
-    // Dot product of velocities and displacement vectors
-    float dot_v1 = (ball1.vx - ball2.vx) * dx + (ball1.vy - ball2.vy) * dy;
-    float dot_v2 = (ball2.vx - ball1.vx) * dx + (ball2.vy - ball1.vy) * dy;
-
-    // Scalar terms for updating velocities
-    float scalar1 = (2 * m2) / (m1 + m2) * dot_v1 / (d_mids * d_mids);
-    float scalar2 = (2 * m1) / (m1 + m2) * dot_v2 / (d_mids * d_mids);
+    return _core->getBall(index);
+}
 
-    // Update velocities of ball1 and ball2
-    ball1.vx -= scalar1 * dx;
-    ball1.vy -= scalar1 * dy;
+void Simulator::drawBall(int centerX, int centerY, int radius, const std::vector<int>& color, const SDL_Rect& clip) 
+{
+    // Set the color for drawing the current specified ball
+    SDL_SetRenderDrawColor(_renderer, color[0], color[1], color[2], 0xFF);
 
-    ball2.vx -= scalar2 * dx;
-    ball2.vy -= scalar2 * dy;
+    // Only the part of the ball inside 'clip' is rasterised (pixel x is centerX + radius - w, pixel y is centerY + radius - h)
+    int first_w = std::max(0, centerX + radius - (clip.x + clip.w - 1));
+    int last_w = std::min(radius * 2 - 1, centerX + radius - clip.x);
+    int first_h = std::max(0, centerY + radius - (clip.y + clip.h - 1));
+    int last_h = std::min(radius * 2 - 1, centerY + radius - clip.y);
 
-    if (loseEnergy) // Take into account energy loss component
+    for (int w = first_w; w <= last_w; w++) 
     {
-        ball1.vx *= sqrt(ball1.collision_elasticity_factor);
-        ball1.vy *= sqrt(ball1.collision_elasticity_factor);
+        for (int h = first_h; h <= last_h; h++) 
+        {
+            int dx = radius - w; // horizontal offset
+            int dy = radius - h; // vertical offset
 
-        ball2.vx *= sqrt(ball2.collision_elasticity_factor);
-        ball2.vy *= sqrt(ball2.collision_elasticity_factor);
+            if ((dx*dx + dy*dy) <= (radius * radius)) 
+            {
+                SDL_RenderDrawPoint(_renderer, centerX + dx, centerY + dy);
+            }
+        }
     }
 }
 
@@ -476,9 +615,10 @@ void Simulator::saveSimulationMetadata() const
     nlohmann::json j;
     j["window_width"] = _window_width;
     j["window_height"] = _window_height;
-    j["x_gravity"] = _x_gravity;
-    j["y_gravity"] = _y_gravity;
-    j["balls"] = _balls;
+    j["x_gravity"] = _core->getXGravity();
+    j["y_gravity"] = _core->getYGravity();
+    j["frame_format"] = getFrameFormatName(_frame_writer_settings.format);
+    _core->saveBalls(j["balls"]); // Double precision runs keep their full precision across resumes
 
     std::ofstream file(JSON_METADATA_FILE_NAME);
     if (file.is_open()) 
@@ -493,7 +633,7 @@ void Simulator::saveSimulationMetadata() const
     }
 }
 
-void Simulator::loadSimulationMetadata() 
+void Simulator::loadSimulationMetadata(const SimCoreSettings& settings) 
 {
     std::ifstream file(JSON_METADATA_FILE_NAME);
     if (file.is_open()) 
@@ -502,11 +642,22 @@ void Simulator::loadSimulationMetadata()
         file >> j;
         file.close();
 
+        float x_gravity, y_gravity;
+
         j.at("window_width").get_to(_window_width);
         j.at("window_height").get_to(_window_height);
-        j.at("x_gravity").get_to(_x_gravity);
-        j.at("y_gravity").get_to(_y_gravity);
-        j.at("balls").get_to(_balls);
+        j.at("x_gravity").get_to(x_gravity);
+        j.at("y_gravity").get_to(y_gravity);
+
+        // Projects saved before the frame format was configurable always stored PNG frames
+        _frame_writer_settings.format = parseFrameFormat(j.value("frame_format", "png"));
+        _resumed_project = true;
+
+        // Balls are read at the precision the core runs in, so double precision state isn't rounded through float
+        if (settings.precision == SimPrecision::Double)
+            _core = createSimCore(settings, _window_width, _window_height, x_gravity, y_gravity, j.at("balls").get<BasicBallSet<double>>());
+        else
+            _core = createSimCore(settings, _window_width, _window_height, x_gravity, y_gravity, j.at("balls").get<BallSet>());
     } 
     else 
     {
@@ -515,29 +666,3 @@ void Simulator::loadSimulationMetadata()
     }
 }
 
-void to_json(nlohmann::json& j, const Ball& b) 
-{
-    j = nlohmann::json{
-        {"x", b.x},
-        {"y", b.y},
-        {"vx", b.vx},
-        {"vy", b.vy},
-        {"radius", b.radius},
-        {"collision_elasticity_factor", b.collision_elasticity_factor},
-        {"color", b.color}
-    };
-}
-
-void from_json(const nlohmann::json& j, Ball& b) 
-{
-    j.at("x").get_to(b.x);
-    j.at("y").get_to(b.y);
-    j.at("vx").get_to(b.vx);
-    j.at("vy").get_to(b.vy);
-    j.at("radius").get_to(b.radius);
-    j.at("collision_elasticity_factor").get_to(b.collision_elasticity_factor);
-    j.at("color").get_to(b.color);
-}
-
-
-
@@ -1,9 +1,14 @@
 #ifndef SIMULATOR_H
 #define SIMULATOR_H
 
+#include "SimCore.h"
+#include "FrameWriter.h"
+#include "MetricsReporter.h"
 #include <SDL2/SDL.h>
 #include <opencv2/opencv.hpp>
 #include "include/json/include/nlohmann/json.hpp"
+#include <algorithm>
+#include <atomic>
 #include <filesystem>
 #include <stdexcept>
 #include <iostream>
@@ -11,72 +16,73 @@
 #include <vector>
 #include <string>
 #include <regex>
-#include <map>
 #include <cmath>
-#include <unordered_set>
 
-struct Ball 
-{
-    float x, y;
-    float vx, vy;
-    int radius;
-    float collision_elasticity_factor; // 0 (all energy lost) to 1 (no energy loss)
-    std::vector<int> color;
-};
+const std::string JSON_METADATA_FILE_NAME = "simulator_data.json";
 
-void to_json(nlohmann::json& j, const Ball& b);
-void from_json(const nlohmann::json& j, Ball& b);
+// Fraction of the window covered by dirty rectangles above which the whole frame is redrawn instead
+const float FULL_REDRAW_COVERAGE_THRESHOLD = 0.5f;
 
-const std::string JSON_METADATA_FILE_NAME = "simulator_data.json";
+// Number of balls that may move in one frame before the whole frame is redrawn instead of tracking dirty rectangles
+const std::size_t MAX_DIRTY_RECTS = 256;
 
-const std::vector<std::vector<int>> POSSIBLE_BALL_COLORS = {{255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {204, 204, 0}, {102, 204, 0},
-    {0, 204, 0}, {0, 204, 102}, {0, 204, 204}, {0, 102, 204}, {0, 0, 204}, {102, 0, 204}, {204, 0, 204}, {204, 0, 102},
-    {153, 76, 0}, {153, 153, 0}, {76, 153, 0}, {0, 153, 0}, {0, 153, 76}, {0, 153, 153}, {0, 76, 153}, {0, 0, 153}, {76, 0, 153},
-    {153, 0, 153}, {153, 0, 76}, {204, 102, 0}, {153, 0, 0}, {204, 0, 0}, {255, 128, 0}, {255, 255, 0}, {128, 255, 0},
-    {0, 255, 128}, {0, 255, 255}, {0, 128, 255}, {127, 0, 255}, {255, 0, 255}, {255, 0, 127}, {255, 51, 51}, {255, 153, 51},
-    {255, 255, 51}, {153, 255, 51}, {51, 255, 51}, {51, 255, 153}, {51, 255, 255}, {51, 153, 255}, {51, 51, 255}, {153, 51, 255},
-    {255, 51, 255}, {255, 51, 153}, {255, 178, 102}, {255, 255, 102}, {178, 255, 102}, {102, 255, 102}, {102, 255, 178},
-    {102, 255, 255}, {102, 178, 255}, {102, 102, 255}, {178, 102, 255}, {255, 102, 255}, {255, 102, 178}};
+// Side length in pixels of the grid cells used to find the balls overlapping a dirty rectangle
+const int BALL_GRID_CELL_SIZE = 64;
 
 class Simulator
 {
 private:
     int _window_width, _window_height;
-    float _x_gravity, _y_gravity;
     SDL_Window* _window;
     SDL_Renderer* _renderer;
-    std::vector<Ball> _balls;
-    std::multimap<float, std::string> _current_1D_Ball_locations;
-    std::vector<std::pair<int, int>> _current_collisions;
+    SDL_Texture* _frame_texture; // Render target that keeps the previous frame for incremental redraws
+    std::unique_ptr<SimCore> _core;
+    const Ball* _ball_data; // Core's ball array, read in place while rendering; nullptr for double precision cores
+    std::vector<SDL_Point> _previous_ball_centers; // Where each ball was drawn in the previous frame
+    std::vector<SDL_Rect> _dirty_rects; // Non-overlapping regions to redraw this frame
+    std::vector<std::vector<int>> _ball_grid; // Indices of the balls whose center lies in each grid cell
+    std::vector<int> _region_balls;
+    bool _has_previous_frame;
+    FrameWriterSettings _frame_writer_settings;
+    bool _resumed_project; // Frames of a loaded project are already stored in its own frame format
+    std::unique_ptr<FrameWriter> _frame_writer; // Only exists while frames are being rendered
+    MetricsSettings _metrics_settings;
+    std::atomic<int> _current_frame;
 public:
     Simulator(int width, int height);
-    Simulator(int width, int height, float x_gravity, float y_gravity, std::vector<Ball>& balls);
-    Simulator();
+    Simulator(int width, int height, float x_gravity, float y_gravity, BallSet balls, const SimCoreSettings& settings = SimCoreSettings());
+    explicit Simulator(const SimCoreSettings& settings = SimCoreSettings());
     ~Simulator();
     void runSimulation(int num_frames);
     void createVideoFromFrames(int frame_rate, const std::string& save_directory, bool remove_metadata);
     void saveSimulationMetadata() const;
     void deleteTempImageFiles();
+    void setFrameWriterSettings(const FrameWriterSettings& settings);
+    void setMetricsSettings(const MetricsSettings& settings);
+    const SimCore& getCore() const;
 private:
     void initializeSimulation();
     void initializeSDL();
     void createSDLWindow();
     void createSDLRenderer();
-    void updateSimulation();
-    void renderSimulation();
-    void update1DBallLocations();
-    void generateCollisionPairs();
-    void handleBallCollisions();
-    void handleSingleBallCollisionInstance(int ball_num1, int ball_num2, bool loseEnergy);
-    void handleWallCollisionForSpecificBall(Ball& current_ball);
-    std::pair<int, int> getCollidedPair();
-    void saveFrame(const std::string& filename);
-    void drawBall(int centerX, int centerY, int radius, std::vector<int>& color);
-    void updateBallPosition(Ball& current_ball);
-    bool collisionDetected(int ball_num1, int ball_num2);
+    void createFrameBuffer();
+    bool renderSimulation();
+    void renderFullFrame();
+    void renderDirtyRegions();
+    void storeBallCenters();
+    std::size_t collectDirtyRects();
+    void mergeDirtyRects();
+    void buildBallGrid(int grid_columns, int grid_rows);
+    static SDL_Rect getBallBounds(const SDL_Point& center, int radius);
+    void saveFrame(int frame);
+    RunMetrics sampleRunMetrics(int end_frame) const;
+    void drawBall(int centerX, int centerY, int radius, const std::vector<int>& color, const SDL_Rect& clip);
+    void writeImageFramesToVideo(cv::VideoWriter& writer, int num_frames);
+    void writeRawFramesToVideo(cv::VideoWriter& writer, int num_frames);
     int getLastSavedPhotoFrameNum();
     void drawAllBalls();
-    void loadSimulationMetadata();
+    Ball getBall(std::size_t index) const;
+    void loadSimulationMetadata(const SimCoreSettings& settings);
 };
 
 #endif
\ No newline at end of file
@@ -20,9 +20,12 @@ struct Config
     int frame_rate;
     float ball_elasticity;
     int num_balls;
+    SimCoreSettings core_settings;
+    FrameWriterSettings frame_writer_settings;
+    MetricsSettings metrics_settings;
 };
 
-std::vector<Ball> get_random_balls(int num_balls, Config& config);
+BallSet get_random_balls(int num_balls, Config& config);
 Config loadConfig(const std::string& filename);
 bool beginNewProject();
 char getSaveChoice();
@@ -38,8 +41,11 @@ int main()
 
     if (start_new_project)
     {
-        std::vector<Ball> balls = get_random_balls(config.num_balls, config);
-        Simulator ball_simulator(config.window_width, config.window_height, config.x_gravity, config.y_gravity, balls);
+        BallSet balls = get_random_balls(config.num_balls, config);
+        Simulator ball_simulator(config.window_width, config.window_height, config.x_gravity, config.y_gravity, std::move(balls),
+            config.core_settings);
+        ball_simulator.setFrameWriterSettings(config.frame_writer_settings);
+        ball_simulator.setMetricsSettings(config.metrics_settings);
 
 
 
@@ -59,7 +65,9 @@ int main()
     }
     else // Load existing project
     {
-        Simulator ball_simulator;
+        Simulator ball_simulator(config.core_settings);
+        ball_simulator.setFrameWriterSettings(config.frame_writer_settings);
+        ball_simulator.setMetricsSettings(config.metrics_settings);
 
 
 
@@ -108,6 +116,16 @@ Config loadConfig(const std::string& filename)
         config.frame_rate = j["FRAME_RATE"];
         config.ball_elasticity = j["BALL_ELASTICITY"];
         config.num_balls = j["NUM_BALLS"];
+        config.core_settings.precision = parseSimPrecision(j.value("PRECISION", "float"));
+        config.core_settings.broadphase = parseSimBroadphase(j.value("BROADPHASE", "sweep_and_prune"));
+        config.core_settings.adaptive_substepping = j.value("ADAPTIVE_SUBSTEPPING", false);
+        config.core_settings.max_substeps = j.value("MAX_SUBSTEPS", 16);
+        config.frame_writer_settings.format = parseFrameFormat(j.value("FRAME_FORMAT", "png"));
+        config.frame_writer_settings.png_compression = j.value("PNG_COMPRESSION", 3);
+        config.frame_writer_settings.num_buffers = j.value("FRAME_BUFFERS", 8);
+        config.frame_writer_settings.num_threads = j.value("FRAME_WRITER_THREADS", 0);
+        config.metrics_settings.file_name = j.value("METRICS_FILE", "");
+        config.metrics_settings.interval_ms = j.value("METRICS_INTERVAL_MS", 1000);
 
         return config;
     }
@@ -118,9 +136,10 @@ Config loadConfig(const std::string& filename)
     }
 }
 
-std::vector<Ball> get_random_balls(int num_balls, Config& config)
+BallSet get_random_balls(int num_balls, Config& config)
 {
-    std::vector<Ball> ball_list;
+    BallSet ball_list;
+    ball_list.balls.reserve(num_balls);
 
     // Define range of possible starting positions
     int min_x_pos = config.max_radius;
@@ -144,10 +163,8 @@ std::vector<Ball> get_random_balls(int num_balls, Config& config)
 
         rand_color_index = rand() % POSSIBLE_BALL_COLORS.size();
 
-        Ball b = {static_cast<float>(x_pos), static_cast<float>(y_pos), static_cast<float>(x_vel), static_cast<float>(y_vel),
-            radius, config.ball_elasticity, POSSIBLE_BALL_COLORS[rand_color_index]};
-
-        ball_list.push_back(b);
+        ball_list.addBall(static_cast<float>(x_pos), static_cast<float>(y_pos), static_cast<float>(x_vel), static_cast<float>(y_vel),
+            radius, config.ball_elasticity, rand_color_index);
     }
 
     return ball_list;